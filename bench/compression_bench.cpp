@@ -0,0 +1,109 @@
+#include "compression.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Measure process CPU time against bytes on the wire for /listnotes-like
+// responses.
+// Build with -DWEBNOTE_BUILD_BENCH=ON and run ./build/compression_bench.
+
+static const std::vector<std::string> words = {
+    "meeting", "project",  "deadline", "review",  "backend", "database",
+    "query",   "customer", "release",  "the",     "a",       "and",
+    "to",      "of",       "with",     "for",     "note",    "remember",
+    "update",  "server",   "client",   "fix",     "bug",     "schedule",
+    "monday",  "friday",   "call",     "email",   "draft",   "budget",
+    "design",  "feedback", "sprint",   "team",    "todo",    "idea",
+    "shopping", "list",    "milk",     "bread",   "book",    "chapter"};
+
+// Build a JSON body shaped like the /listnotes response.
+static std::string makeNotesPage(size_t note_count, std::mt19937 &rng) {
+  std::uniform_int_distribution<size_t> word(0, words.size() - 1);
+  std::uniform_int_distribution<int> description_words(50, 400);
+  std::uniform_int_distribution<int> day(1, 28);
+
+  std::ostringstream s;
+  s << "{\"notes\":[";
+  for (size_t i = 0; i < note_count; ++i) {
+    if (i != 0) {
+      s << ',';
+    }
+    s << "{\"creation_date\":\"2024-05-" << day(rng)
+      << " 10:21:33.512+07\",\"description\":\"";
+    int n = description_words(rng);
+    for (int w = 0; w < n; ++w) {
+      s << (w == 0 ? "" : " ") << words[word(rng)];
+    }
+    s << "\",\"id\":" << 1000 + i << ",\"last_update_date\":\"2024-06-"
+      << day(rng) << " 08:02:11.104+07\",\"title\":\"" << words[word(rng)]
+      << ' ' << words[word(rng)] << "\",\"username\":\"hitagi\"}";
+  }
+  s << "]}";
+  return s.str();
+}
+
+static void run(const char *name, const std::string &body,
+                wnt::Encoding encoding, int level) {
+  std::string output;
+  // Warm up the per-thread compressor context.
+  if (!wnt::compress(encoding, level, body, output)) {
+    std::printf("%-10s %-8s %2d  failed\n", name, wnt::encoding_name(encoding),
+                level);
+    return;
+  }
+
+  // Repeat until roughly 16 MB has been compressed, between 100 and 100000
+  // times.
+  size_t iterations =
+      std::clamp<size_t>((16u << 20) / body.size(), 100, 100000);
+  std::clock_t start = std::clock();
+  for (size_t i = 0; i < iterations; ++i) {
+    wnt::compress(encoding, level, body, output);
+  }
+  double cpu_us = 1e6 * (std::clock() - start) / CLOCKS_PER_SEC;
+
+  double us_per_op = cpu_us / iterations;
+  double mb_per_s = body.size() / us_per_op;
+  std::printf("%-10s %-8s %2d %10zu %10zu %7.3f %10.2f %9.1f\n", name,
+              wnt::encoding_name(encoding), level, body.size(), output.size(),
+              static_cast<double>(output.size()) / body.size(), us_per_op,
+              mb_per_s);
+}
+
+int main() {
+  std::mt19937 rng(42);
+
+  struct Page {
+    const char *name;
+    std::string body;
+  };
+  std::vector<Page> pages = {
+      {"ok", "OK"},
+      {"notes-1", makeNotesPage(1, rng)},
+      {"notes-10", makeNotesPage(10, rng)},
+      {"notes-50", makeNotesPage(50, rng)},
+      {"notes-200", makeNotesPage(200, rng)},
+  };
+
+  std::vector<wnt::Encoding> encodings = {wnt::Encoding::GZIP,
+                                          wnt::Encoding::DEFLATE};
+#ifdef WNT_HAVE_ZSTD
+  encodings.push_back(wnt::Encoding::ZSTD);
+#endif
+
+  std::printf("%-10s %-8s %2s %10s %10s %7s %10s %9s\n", "page", "encoding",
+              "lv", "bytes", "wire", "ratio", "cpu us", "MB/cpu-s");
+  for (const auto &page : pages) {
+    for (auto encoding : encodings) {
+      for (int level : {1, 6, 9}) {
+        run(page.name, page.body, encoding, level);
+      }
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+namespace wnt {
+enum class Encoding : uint8_t { IDENTITY = 0, GZIP, DEFLATE, ZSTD };
+
+// Compression settings for a route. Responses smaller than min_size are sent
+// as-is, level is passed to the underlying compressor.
+struct CompressionPolicy {
+  size_t min_size;
+  int level;
+};
+
+// Token used in Content-Encoding header, empty for identity.
+const char *encoding_name(const Encoding e);
+
+// Pick the best supported encoding from an Accept-Encoding header value.
+// Preference on equal q-values is zstd (when built in), gzip then deflate.
+Encoding negotiate_encoding(const std::string &accept_encoding);
+
+// Compress input into output using a compressor context owned by the calling
+// thread, so no deflate/zstd state is allocated per response.
+bool compress(Encoding encoding, int level, const std::string &input,
+              std::string &output);
+} // namespace wnt
@@ -0,0 +1,236 @@
+#include "compression.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <string>
+#include <zlib.h>
+#ifdef WNT_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+// References:
+// https://www.zlib.net/manual.html#Advanced
+// A deflate stream is initialized once per thread and reset between responses.
+// windowBits 15 + 16 writes a gzip wrapper, 15 alone writes the zlib wrapper
+// expected by "Content-Encoding: deflate".
+class DeflateContext {
+public:
+  explicit DeflateContext(int window_bits) {
+    stream_ = {};
+    ok_ = deflateInit2(&stream_, Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                       window_bits, 8, Z_DEFAULT_STRATEGY) == Z_OK;
+    level_ = Z_DEFAULT_COMPRESSION;
+  }
+  ~DeflateContext() {
+    if (ok_) {
+      deflateEnd(&stream_);
+    }
+  }
+  DeflateContext(const DeflateContext &) = delete;
+  DeflateContext &operator=(const DeflateContext &) = delete;
+
+  bool compress(int level, const std::string &input, std::string &output) {
+    if (!ok_ || deflateReset(&stream_) != Z_OK) {
+      return false;
+    }
+    // With the default window and memory sizes used here deflateBound does
+    // not depend on the level, so the buffer can be sized before
+    // deflateParams. Output pointers must be set first: zlib 1.2.11 and older
+    // may flush the header from deflateParams after a reset, which would
+    // otherwise write through pointers left by the previous response.
+    output.resize(deflateBound(&stream_, input.size()));
+    stream_.next_in = Z_NULL;
+    stream_.avail_in = 0;
+    stream_.next_out = reinterpret_cast<Bytef *>(output.data());
+    stream_.avail_out = static_cast<uInt>(output.size());
+    if (level != level_) {
+      if (deflateParams(&stream_, level, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+      }
+      level_ = level;
+    }
+
+    stream_.next_in =
+        reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+    stream_.avail_in = static_cast<uInt>(input.size());
+
+    // Output buffer is sized with deflateBound, so a single call finishes.
+    if (deflate(&stream_, Z_FINISH) != Z_STREAM_END) {
+      return false;
+    }
+    output.resize(stream_.total_out);
+    return true;
+  }
+
+private:
+  z_stream stream_;
+  int level_;
+  bool ok_;
+};
+
+#ifdef WNT_HAVE_ZSTD
+class ZstdContext {
+public:
+  ZstdContext() : cctx_(ZSTD_createCCtx()) {}
+  ~ZstdContext() { ZSTD_freeCCtx(cctx_); }
+  ZstdContext(const ZstdContext &) = delete;
+  ZstdContext &operator=(const ZstdContext &) = delete;
+
+  bool compress(int level, const std::string &input, std::string &output) {
+    if (cctx_ == nullptr) {
+      return false;
+    }
+    output.resize(ZSTD_compressBound(input.size()));
+    size_t size = ZSTD_compressCCtx(cctx_, output.data(), output.size(),
+                                    input.data(), input.size(), level);
+    if (ZSTD_isError(size)) {
+      return false;
+    }
+    output.resize(size);
+    return true;
+  }
+
+private:
+  ZSTD_CCtx *cctx_;
+};
+#endif
+
+// Case-insensitive comparison for content-coding tokens.
+bool isToken(const std::string &value, const char *token) {
+  size_t i = 0;
+  for (; token[i] != '\0'; ++i) {
+    if (i >= value.size() ||
+        std::tolower(static_cast<unsigned char>(value[i])) != token[i]) {
+      return false;
+    }
+  }
+  return i == value.size();
+}
+
+std::string trim(const std::string &s) {
+  size_t begin = s.find_first_not_of(" \t");
+  if (begin == std::string::npos) {
+    return "";
+  }
+  size_t end = s.find_last_not_of(" \t");
+  return s.substr(begin, end - begin + 1);
+}
+} // namespace
+
+namespace wnt {
+const char *encoding_name(const Encoding e) {
+  switch (e) {
+  case Encoding::GZIP:
+    return "gzip";
+  case Encoding::DEFLATE:
+    return "deflate";
+  case Encoding::ZSTD:
+    return "zstd";
+  case Encoding::IDENTITY:
+  default:
+    return "";
+  }
+}
+
+// References:
+// https://www.rfc-editor.org/rfc/rfc9110#field.accept-encoding
+Encoding negotiate_encoding(const std::string &accept_encoding) {
+  // q-values of supported codings, -1 means not listed.
+  double q_gzip = -1, q_deflate = -1, q_zstd = -1, q_any = -1;
+
+  size_t pos = 0;
+  while (pos <= accept_encoding.size()) {
+    size_t comma = accept_encoding.find(',', pos);
+    if (comma == std::string::npos) {
+      comma = accept_encoding.size();
+    }
+    std::string item = accept_encoding.substr(pos, comma - pos);
+    pos = comma + 1;
+
+    // Split "coding;param=value;q=value", parameters may come in any order.
+    double q = 1.0;
+    size_t semicolon = item.find(';');
+    if (semicolon != std::string::npos) {
+      size_t param_pos = semicolon + 1;
+      while (param_pos <= item.size()) {
+        size_t next = item.find(';', param_pos);
+        if (next == std::string::npos) {
+          next = item.size();
+        }
+        std::string param = trim(item.substr(param_pos, next - param_pos));
+        param_pos = next + 1;
+        if (param.size() > 2 && (param[0] == 'q' || param[0] == 'Q') &&
+            param[1] == '=') {
+          q = std::strtod(param.c_str() + 2, nullptr);
+        }
+      }
+      item = item.substr(0, semicolon);
+    }
+    item = trim(item);
+
+    if (isToken(item, "gzip") || isToken(item, "x-gzip")) {
+      q_gzip = q;
+    } else if (isToken(item, "deflate")) {
+      q_deflate = q;
+    } else if (isToken(item, "zstd")) {
+      q_zstd = q;
+    } else if (item == "*") {
+      q_any = q;
+    }
+  }
+
+  // Codings not listed explicitly inherit the wildcard q-value.
+  if (q_gzip < 0) {
+    q_gzip = q_any;
+  }
+  if (q_deflate < 0) {
+    q_deflate = q_any;
+  }
+  if (q_zstd < 0) {
+    q_zstd = q_any;
+  }
+#ifndef WNT_HAVE_ZSTD
+  q_zstd = -1;
+#endif
+
+  Encoding best = Encoding::IDENTITY;
+  double best_q = 0;
+  if (q_zstd > best_q) {
+    best = Encoding::ZSTD;
+    best_q = q_zstd;
+  }
+  if (q_gzip > best_q) {
+    best = Encoding::GZIP;
+    best_q = q_gzip;
+  }
+  if (q_deflate > best_q) {
+    best = Encoding::DEFLATE;
+    best_q = q_deflate;
+  }
+  return best;
+}
+
+bool compress(Encoding encoding, int level, const std::string &input,
+              std::string &output) {
+  switch (encoding) {
+  case Encoding::GZIP: {
+    thread_local DeflateContext gzip_context(MAX_WBITS + 16);
+    return gzip_context.compress(level, input, output);
+  }
+  case Encoding::DEFLATE: {
+    thread_local DeflateContext deflate_context(MAX_WBITS);
+    return deflate_context.compress(level, input, output);
+  }
+#ifdef WNT_HAVE_ZSTD
+  case Encoding::ZSTD: {
+    thread_local ZstdContext zstd_context;
+    return zstd_context.compress(level, input, output);
+  }
+#endif
+  default:
+    return false;
+  }
+}
+} // namespace wnt
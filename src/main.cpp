@@ -1,3 +1,4 @@
+#include "compression.h"
 #include "db.h"
 
 #include <chrono>
@@ -15,6 +16,7 @@
 #include <jwt-cpp/traits/kazuho-picojson/defaults.h>
 #include <regex>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <variant>
 
@@ -34,6 +36,64 @@ struct logRequest {
   }
 };
 
+// Compress response body according to Accept-Encoding and a per-route policy.
+struct compressResponse {
+  struct context {};
+
+  // Used for routes without their own policy, large enough to leave short
+  // replies like "OK" untouched.
+  wnt::CompressionPolicy default_policy{1024, 1};
+  std::unordered_map<std::string, wnt::CompressionPolicy> route_policy;
+
+  // Set policy for a route path. Must be called before the app runs.
+  compressResponse &route(const std::string &url,
+                          wnt::CompressionPolicy policy) {
+    route_policy[url] = policy;
+    return *this;
+  }
+
+  void before_handle(crow::request &req, crow::response &res, context &ctx) {}
+
+  void after_handle(crow::request &req, crow::response &res, context &ctx) {
+    // Response is already encoded.
+    if (!res.get_header_value("Content-Encoding").empty()) {
+      return;
+    }
+
+    const auto &i = route_policy.find(req.url);
+    const wnt::CompressionPolicy &policy =
+        i == route_policy.end() ? default_policy : i->second;
+    if (res.body.size() < policy.min_size) {
+      return;
+    }
+
+    // Body is large enough to vary on the request header, keep any Vary
+    // value set by the handler.
+    res.add_header("Vary", "Accept-Encoding");
+
+    wnt::Encoding encoding =
+        wnt::negotiate_encoding(req.get_header_value("Accept-Encoding"));
+    if (encoding == wnt::Encoding::IDENTITY) {
+      return;
+    }
+
+    std::string compressed;
+    if (!wnt::compress(encoding, policy.level, res.body, compressed)) {
+      CROW_LOG_ERROR << "Failed to compress response: " + req.url;
+      return;
+    }
+    // Not worth it if compression does not shrink the body.
+    if (compressed.size() >= res.body.size()) {
+      return;
+    }
+
+    CROW_LOG_DEBUG << "Compressed response " << req.url << ": "
+                   << res.body.size() << " -> " << compressed.size();
+    res.body = std::move(compressed);
+    res.set_header("Content-Encoding", wnt::encoding_name(encoding));
+  }
+};
+
 // Authorization header validation.
 static bool isHeaderVerified(const crow::request &req, std::string &username);
 
@@ -43,7 +103,7 @@ static bool isStringPresent(const crow::multipart::message &messages,
 
 int main(int argc, char *argv[]) {
   // Define app and use middleware.
-  crow::App<logRequest, crow::CORSHandler> app;
+  crow::App<logRequest, crow::CORSHandler, compressResponse> app;
 
   // Customize CORS.
   auto &cors = app.get_middleware<crow::CORSHandler>();
@@ -56,6 +116,12 @@ int main(int argc, char *argv[]) {
       .origin("http://localhost:8080")
       .allow_credentials();
 
+  // Note lists can grow to hundreds of KB, compress them from a smaller size.
+  // Level 1 keeps most of the size reduction at a fraction of the CPU cost,
+  // see bench/compression_bench.cpp.
+  auto &compression = app.get_middleware<compressResponse>();
+  compression.route("/listnotes", {256, 1});
+
   CROW_ROUTE(app, "/signup")
       .methods(crow::HTTPMethod::POST)([](const crow::request &req) {
         crow::multipart::message messages(req);
@@ -0,0 +1,141 @@
+#include "compression.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <zlib.h>
+#ifdef WNT_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+// Accept-Encoding comes straight from the client, check the parser against
+// the cases that decide whether a response may be compressed at all. Then
+// check that compressed bodies decode back to the input while the per-thread
+// contexts switch levels between responses.
+
+static int failures = 0;
+
+static void expect(const std::string &accept_encoding, wnt::Encoding expected) {
+  wnt::Encoding actual = wnt::negotiate_encoding(accept_encoding);
+  if (actual != expected) {
+    std::printf("FAIL \"%s\": expected \"%s\", got \"%s\"\n",
+                accept_encoding.c_str(), wnt::encoding_name(expected),
+                wnt::encoding_name(actual));
+    ++failures;
+  }
+}
+
+static bool decompress(wnt::Encoding encoding, const std::string &input,
+                       std::string &output) {
+#ifdef WNT_HAVE_ZSTD
+  if (encoding == wnt::Encoding::ZSTD) {
+    unsigned long long size =
+        ZSTD_getFrameContentSize(input.data(), input.size());
+    if (size == ZSTD_CONTENTSIZE_UNKNOWN || size == ZSTD_CONTENTSIZE_ERROR) {
+      return false;
+    }
+    output.resize(size);
+    size_t result = ZSTD_decompress(output.data(), output.size(),
+                                    input.data(), input.size());
+    return !ZSTD_isError(result) && result == size;
+  }
+#endif
+
+  // windowBits 31 expects a gzip wrapper, 15 a zlib wrapper.
+  z_stream stream = {};
+  int window_bits =
+      encoding == wnt::Encoding::GZIP ? MAX_WBITS + 16 : MAX_WBITS;
+  if (inflateInit2(&stream, window_bits) != Z_OK) {
+    return false;
+  }
+  output.clear();
+  char buffer[16384];
+  stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(input.data()));
+  stream.avail_in = static_cast<uInt>(input.size());
+  int result = Z_OK;
+  while (result == Z_OK) {
+    stream.next_out = reinterpret_cast<Bytef *>(buffer);
+    stream.avail_out = sizeof(buffer);
+    result = inflate(&stream, Z_NO_FLUSH);
+    output.append(buffer, sizeof(buffer) - stream.avail_out);
+  }
+  inflateEnd(&stream);
+  return result == Z_STREAM_END && stream.avail_in == 0;
+}
+
+static void expect_round_trip(wnt::Encoding encoding, int level,
+                              const std::string &input) {
+  std::string compressed, decompressed;
+  if (!wnt::compress(encoding, level, input, compressed)) {
+    std::printf("FAIL %s level %d: compress failed\n",
+                wnt::encoding_name(encoding), level);
+    ++failures;
+    return;
+  }
+  if (!decompress(encoding, compressed, decompressed) ||
+      decompressed != input) {
+    std::printf("FAIL %s level %d: body does not round-trip\n",
+                wnt::encoding_name(encoding), level);
+    ++failures;
+  }
+}
+
+int main() {
+  // No header or nothing acceptable.
+  expect("", wnt::Encoding::IDENTITY);
+  expect("identity", wnt::Encoding::IDENTITY);
+  expect("*;q=0", wnt::Encoding::IDENTITY);
+  expect("br", wnt::Encoding::IDENTITY);
+
+  // Refused codings.
+  expect("gzip;q=0", wnt::Encoding::IDENTITY);
+  expect("gzip;q=0, deflate", wnt::Encoding::DEFLATE);
+  expect("GZIP;Q=0, zstd;q=0, *", wnt::Encoding::DEFLATE);
+
+  // q is not always the first parameter.
+  expect("gzip;foo=1;q=0", wnt::Encoding::IDENTITY);
+  expect("gzip ; foo=1 ; q=0.5, deflate;q=0.8", wnt::Encoding::DEFLATE);
+
+  // Explicit q ordering wins over server preference.
+  expect("gzip, deflate", wnt::Encoding::GZIP);
+  expect("deflate;q=1, gzip;q=0.5", wnt::Encoding::DEFLATE);
+  expect("gzip;q=0.2, deflate;q=0.3", wnt::Encoding::DEFLATE);
+  expect("x-gzip", wnt::Encoding::GZIP);
+
+  // zstd is preferred on equal q-values only when built in.
+#ifdef WNT_HAVE_ZSTD
+  expect("zstd, gzip", wnt::Encoding::ZSTD);
+  expect("*", wnt::Encoding::ZSTD);
+#else
+  expect("zstd, gzip", wnt::Encoding::GZIP);
+  expect("zstd", wnt::Encoding::IDENTITY);
+#endif
+
+  // Alternate levels on one thread so the reused context crosses the 1-3 and
+  // 4-9 groups after deflateReset.
+  std::string body = "{\"notes\":[";
+  for (int i = 0; i < 200; ++i) {
+    body += "{\"id\":" + std::to_string(i) +
+            ",\"title\":\"note\",\"description\":\"meeting notes " +
+            std::to_string(i * 7919) + " for the project review\"},";
+  }
+  body += "{}]}";
+
+  std::vector<wnt::Encoding> encodings = {wnt::Encoding::GZIP,
+                                          wnt::Encoding::DEFLATE};
+#ifdef WNT_HAVE_ZSTD
+  encodings.push_back(wnt::Encoding::ZSTD);
+#endif
+  for (auto encoding : encodings) {
+    for (int level : {1, 6, 1, 9}) {
+      expect_round_trip(encoding, level, body);
+    }
+    expect_round_trip(encoding, 1, "OK");
+  }
+
+  if (failures != 0) {
+    std::printf("%d case(s) failed\n", failures);
+    return 1;
+  }
+  return 0;
+}